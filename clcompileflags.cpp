@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#include "clcompileflags.h"
+#include "perfecthash.h"
+
+namespace
+{
+    enum class ClSettingKind : std::uint8_t
+    {
+        Enumerated, // the value is looked up in clFlagTable
+        AdditionalIncludeDirectories,
+        PreprocessorDefinitions,
+        ForcedIncludeFiles,
+        DisableSpecificWarnings,
+        UndefinePreprocessorDefinitions,
+        AdditionalOptions,
+    };
+
+    enum class ClFlagTarget : std::uint8_t
+    {
+        Options,
+        CppLanguageStandard,
+        CLanguageStandard,
+    };
+
+    struct ClSettingEntry
+    {
+        std::string_view element;
+        std::string_view value; // always empty, settings are keyed by element name only
+        ClSettingKind    kind;
+    };
+
+    struct ClFlagEntry
+    {
+        std::string_view element;
+        std::string_view value;
+        std::string_view flag; // empty if the value is the cl default and needs no flag
+        ClFlagTarget     target = ClFlagTarget::Options;
+    };
+
+    constexpr std::array clSettingTable = {
+        ClSettingEntry {"AdditionalIncludeDirectories", {}, ClSettingKind::AdditionalIncludeDirectories},
+        ClSettingEntry {"PreprocessorDefinitions", {}, ClSettingKind::PreprocessorDefinitions},
+        ClSettingEntry {"ForcedIncludeFiles", {}, ClSettingKind::ForcedIncludeFiles},
+        ClSettingEntry {"DisableSpecificWarnings", {}, ClSettingKind::DisableSpecificWarnings},
+        ClSettingEntry {"UndefinePreprocessorDefinitions", {}, ClSettingKind::UndefinePreprocessorDefinitions},
+        ClSettingEntry {"AdditionalOptions", {}, ClSettingKind::AdditionalOptions},
+        ClSettingEntry {"LanguageStandard", {}, ClSettingKind::Enumerated},
+        ClSettingEntry {"LanguageStandard_C", {}, ClSettingKind::Enumerated},
+        ClSettingEntry {"RuntimeLibrary", {}, ClSettingKind::Enumerated},
+        ClSettingEntry {"ExceptionHandling", {}, ClSettingKind::Enumerated},
+        ClSettingEntry {"ConformanceMode", {}, ClSettingKind::Enumerated},
+        ClSettingEntry {"TreatWChar_tAsBuiltInType", {}, ClSettingKind::Enumerated},
+        ClSettingEntry {"EnableEnhancedInstructionSet", {}, ClSettingKind::Enumerated},
+        ClSettingEntry {"RuntimeTypeInfo", {}, ClSettingKind::Enumerated},
+        ClSettingEntry {"WarningLevel", {}, ClSettingKind::Enumerated},
+        ClSettingEntry {"TreatWarningAsError", {}, ClSettingKind::Enumerated},
+        ClSettingEntry {"Optimization", {}, ClSettingKind::Enumerated},
+        ClSettingEntry {"FloatingPointModel", {}, ClSettingKind::Enumerated},
+        ClSettingEntry {"CallingConvention", {}, ClSettingKind::Enumerated},
+        ClSettingEntry {"OpenMPSupport", {}, ClSettingKind::Enumerated},
+        ClSettingEntry {"UseStandardPreprocessor", {}, ClSettingKind::Enumerated},
+        ClSettingEntry {"BufferSecurityCheck", {}, ClSettingKind::Enumerated},
+    };
+
+    constexpr std::array clFlagTable = {
+        ClFlagEntry {"LanguageStandard", "Default", "", ClFlagTarget::CppLanguageStandard},
+        ClFlagEntry {"LanguageStandard", "stdcpp11", "/std:c++11", ClFlagTarget::CppLanguageStandard},
+        ClFlagEntry {"LanguageStandard", "stdcpp14", "/std:c++14", ClFlagTarget::CppLanguageStandard},
+        ClFlagEntry {"LanguageStandard", "stdcpp17", "/std:c++17", ClFlagTarget::CppLanguageStandard},
+        ClFlagEntry {"LanguageStandard", "stdcpp20", "/std:c++20", ClFlagTarget::CppLanguageStandard},
+        ClFlagEntry {"LanguageStandard", "stdcpp23", "/std:c++23", ClFlagTarget::CppLanguageStandard},
+        ClFlagEntry {"LanguageStandard", "stdcpplatest", "/std:c++latest", ClFlagTarget::CppLanguageStandard},
+        ClFlagEntry {"LanguageStandard_C", "Default", "", ClFlagTarget::CLanguageStandard},
+        ClFlagEntry {"LanguageStandard_C", "stdc11", "/std:c11", ClFlagTarget::CLanguageStandard},
+        ClFlagEntry {"LanguageStandard_C", "stdc17", "/std:c17", ClFlagTarget::CLanguageStandard},
+        ClFlagEntry {"LanguageStandard_C", "stdclatest", "/std:clatest", ClFlagTarget::CLanguageStandard},
+        ClFlagEntry {"RuntimeLibrary", "MultiThreaded", "/MT"},
+        ClFlagEntry {"RuntimeLibrary", "MultiThreadedDebug", "/MTd"},
+        ClFlagEntry {"RuntimeLibrary", "MultiThreadedDLL", "/MD"},
+        ClFlagEntry {"RuntimeLibrary", "MultiThreadedDebugDLL", "/MDd"},
+        ClFlagEntry {"ExceptionHandling", "false", ""},
+        ClFlagEntry {"ExceptionHandling", "Sync", "/EHsc"},
+        ClFlagEntry {"ExceptionHandling", "SyncCThrow", "/EHs"},
+        ClFlagEntry {"ExceptionHandling", "Async", "/EHa"},
+        ClFlagEntry {"ConformanceMode", "true", "/permissive-"},
+        ClFlagEntry {"ConformanceMode", "false", ""},
+        ClFlagEntry {"TreatWChar_tAsBuiltInType", "true", "/Zc:wchar_t"},
+        ClFlagEntry {"TreatWChar_tAsBuiltInType", "false", "/Zc:wchar_t-"},
+        ClFlagEntry {"EnableEnhancedInstructionSet", "NotSet", ""},
+        ClFlagEntry {"EnableEnhancedInstructionSet", "NoExtensions", "/arch:IA32"},
+        ClFlagEntry {"EnableEnhancedInstructionSet", "StreamingSIMDExtensions", "/arch:SSE"},
+        ClFlagEntry {"EnableEnhancedInstructionSet", "StreamingSIMDExtensions2", "/arch:SSE2"},
+        ClFlagEntry {"EnableEnhancedInstructionSet", "AdvancedVectorExtensions", "/arch:AVX"},
+        ClFlagEntry {"EnableEnhancedInstructionSet", "AdvancedVectorExtensions2", "/arch:AVX2"},
+        ClFlagEntry {"EnableEnhancedInstructionSet", "AdvancedVectorExtensions512", "/arch:AVX512"},
+        ClFlagEntry {"RuntimeTypeInfo", "true", "/GR"},
+        ClFlagEntry {"RuntimeTypeInfo", "false", "/GR-"},
+        ClFlagEntry {"WarningLevel", "TurnOffAllWarnings", "/W0"},
+        ClFlagEntry {"WarningLevel", "Level1", "/W1"},
+        ClFlagEntry {"WarningLevel", "Level2", "/W2"},
+        ClFlagEntry {"WarningLevel", "Level3", "/W3"},
+        ClFlagEntry {"WarningLevel", "Level4", "/W4"},
+        ClFlagEntry {"WarningLevel", "EnableAllWarnings", "/Wall"},
+        ClFlagEntry {"TreatWarningAsError", "true", "/WX"},
+        ClFlagEntry {"TreatWarningAsError", "false", ""},
+        ClFlagEntry {"Optimization", "Disabled", "/Od"},
+        ClFlagEntry {"Optimization", "MinSpace", "/O1"},
+        ClFlagEntry {"Optimization", "MaxSpeed", "/O2"},
+        ClFlagEntry {"Optimization", "Full", "/Ox"},
+        ClFlagEntry {"FloatingPointModel", "Precise", "/fp:precise"},
+        ClFlagEntry {"FloatingPointModel", "Strict", "/fp:strict"},
+        ClFlagEntry {"FloatingPointModel", "Fast", "/fp:fast"},
+        ClFlagEntry {"CallingConvention", "Cdecl", "/Gd"},
+        ClFlagEntry {"CallingConvention", "FastCall", "/Gr"},
+        ClFlagEntry {"CallingConvention", "StdCall", "/Gz"},
+        ClFlagEntry {"CallingConvention", "VectorCall", "/Gv"},
+        ClFlagEntry {"OpenMPSupport", "true", "/openmp"},
+        ClFlagEntry {"OpenMPSupport", "false", ""},
+        ClFlagEntry {"UseStandardPreprocessor", "true", "/Zc:preprocessor"},
+        ClFlagEntry {"UseStandardPreprocessor", "false", ""},
+        ClFlagEntry {"BufferSecurityCheck", "true", ""},
+        ClFlagEntry {"BufferSecurityCheck", "false", "/GS-"},
+    };
+
+    constexpr auto clSettingIndex = perfect_hash::build(clSettingTable);
+    constexpr auto clFlagIndex    = perfect_hash::build(clFlagTable);
+
+    std::string_view trim(std::string_view str)
+    {
+        constexpr std::string_view whitespaces = " \t\r\n";
+
+        const auto first = str.find_first_not_of(whitespaces);
+        if (first == std::string_view::npos)
+        {
+            return {};
+        }
+        return str.substr(first, str.find_last_not_of(whitespaces) - first + 1);
+    }
+
+    // splits a ';' separated MSBuild list, skipping empty items and inherited values like %(PreprocessorDefinitions)
+    template<typename Function>
+    void forEachListItem(std::string_view list, Function function)
+    {
+        while (!list.empty())
+        {
+            const auto separator = list.find(';');
+            const auto item      = trim(list.substr(0, separator));
+            if (!item.empty() && !item.starts_with("%("))
+            {
+                function(item);
+            }
+            if (separator == std::string_view::npos)
+            {
+                break;
+            }
+            list.remove_prefix(separator + 1);
+        }
+    }
+
+    // appends " /<flag><argument>", quoted if the argument has spaces, in the escaped form of a JSON command string
+    void appendFlag(std::string &options, std::string_view flag, std::string_view argument)
+    {
+        const bool hasSpace = argument.find(' ') != std::string_view::npos;
+        options += hasSpace ? R"( \"/)" : " /";
+        options += flag;
+        options += argument;
+        if (hasSpace)
+        {
+            options += R"(\")";
+        }
+    }
+} // namespace
+
+bool applyClCompileSetting(std::string_view element, std::string_view value, ClCompileSettings &settings)
+{
+    const auto settingIndex = clSettingIndex.find(clSettingTable, element, {});
+    if (settingIndex == clSettingTable.size())
+    {
+        return false;
+    }
+
+    switch (clSettingTable[settingIndex].kind)
+    {
+    case ClSettingKind::Enumerated: {
+        const auto flagIndex = clFlagIndex.find(clFlagTable, element, trim(value));
+        if (flagIndex == clFlagTable.size())
+        {
+            return false;
+        }
+        const auto &entry = clFlagTable[flagIndex];
+        switch (entry.target)
+        {
+        case ClFlagTarget::CppLanguageStandard:
+            settings.cppLanguageStandard = entry.flag;
+            break;
+        case ClFlagTarget::CLanguageStandard:
+            settings.cLanguageStandard = entry.flag;
+            break;
+        case ClFlagTarget::Options:
+            if (!entry.flag.empty())
+            {
+                settings.options += ' ';
+                settings.options += entry.flag;
+            }
+            break;
+        }
+        break;
+    }
+    case ClSettingKind::AdditionalIncludeDirectories:
+        settings.hasAdditionalIncludeDirectories = true;
+        forEachListItem(value, [&settings](std::string_view item) { settings.additionalIncludeDirectories.emplace_back(item); });
+        break;
+    case ClSettingKind::PreprocessorDefinitions:
+        settings.hasPreprocessorDefinitions = true;
+        forEachListItem(value, [&settings](std::string_view item) { settings.preprocessorDefinitions.emplace_back(item); });
+        break;
+    case ClSettingKind::ForcedIncludeFiles:
+        forEachListItem(value, [&settings](std::string_view item) {
+            std::string path(item);
+            std::replace(path.begin(), path.end(), '\\', '/');
+            appendFlag(settings.options, "FI", path);
+        });
+        break;
+    case ClSettingKind::DisableSpecificWarnings:
+        forEachListItem(value, [&settings](std::string_view item) { appendFlag(settings.options, "wd", item); });
+        break;
+    case ClSettingKind::UndefinePreprocessorDefinitions:
+        forEachListItem(value, [&settings](std::string_view item) { appendFlag(settings.options, "U", item); });
+        break;
+    case ClSettingKind::AdditionalOptions: {
+        std::string additionalOptions(value);
+        constexpr std::string_view inherited = "%(AdditionalOptions)";
+        for (auto pos = additionalOptions.find(inherited); pos != std::string::npos; pos = additionalOptions.find(inherited))
+        {
+            additionalOptions.erase(pos, inherited.size());
+        }
+        const auto trimmed = trim(additionalOptions);
+        if (trimmed.empty())
+        {
+            break;
+        }
+        // the options are passed through verbatim, so escape them for the JSON command string
+        std::string escaped;
+        for (const char c : trimmed)
+        {
+            if (c == '\\' || c == '"')
+            {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        settings.additionalOptions = " " + escaped;
+        break;
+    }
+    }
+    return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// cl flags collected from the children of an ItemDefinitionGroup/ClCompile node
+struct ClCompileSettings
+{
+    std::string              cppLanguageStandard; // passed to C++ sources only, e.g. /std:c++17
+    std::string              cLanguageStandard;   // passed to C sources only, e.g. /std:c17
+    std::string              options;             // passed to all sources, every flag starts with a space
+    std::string              additionalOptions;   // AdditionalOptions, passed after all other flags
+    std::vector<std::string> additionalIncludeDirectories;
+    std::vector<std::string> preprocessorDefinitions;
+    bool                     hasAdditionalIncludeDirectories = false;
+    bool                     hasPreprocessorDefinitions      = false;
+};
+
+// Translates one ClCompile setting into settings through compile-time perfect hash tables.
+// Returns false if the element or its value is not mapped, settings is left untouched then.
+bool applyClCompileSetting(std::string_view element, std::string_view value, ClCompileSettings &settings);
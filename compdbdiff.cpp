@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "compdbdiff.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr std::uint64_t fnvOffsetBasis = 14695981039346656037ULL;
+    constexpr std::uint64_t fnvPrime       = 1099511628211ULL;
+
+    void hashBytes(std::uint64_t &hash, const std::string &bytes)
+    {
+        for (const char c : bytes)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= fnvPrime;
+        }
+        // terminate every field so that "ab","c" and "a","bc" hash differently
+        hash ^= 0xFFU;
+        hash *= fnvPrime;
+    }
+
+    // probe() reads rendered chunks in place, without copying them into a stream
+    class StringViewSource
+    {
+    public:
+        explicit StringViewSource(std::string_view data) : m_data(data) {}
+
+        [[nodiscard]] int peek() const
+        {
+            return m_position < m_data.size() ? static_cast<unsigned char>(m_data[m_position]) : std::char_traits<char>::eof();
+        }
+        int get()
+        {
+            return m_position < m_data.size() ? static_cast<unsigned char>(m_data[m_position++]) : std::char_traits<char>::eof();
+        }
+        void setstate(std::ios::iostate /*state*/) {}
+
+    private:
+        std::string_view m_data;
+        size_t           m_position = 0;
+    };
+
+    template<typename Source>
+    void skipWhitespace(Source &is)
+    {
+        while (std::isspace(is.peek()))
+        {
+            is.get();
+        }
+    }
+
+    // reads the content of a JSON string whose opening quote has been consumed, escapes are kept as is
+    template<typename Source>
+    bool readString(Source &is, std::string &str)
+    {
+        str.clear();
+        for (int c = is.get(); c != std::char_traits<char>::eof(); c = is.get())
+        {
+            if (c == '"')
+            {
+                return true;
+            }
+            str.push_back(static_cast<char>(c));
+            if (c == '\\')
+            {
+                c = is.get();
+                if (c == std::char_traits<char>::eof())
+                {
+                    return false;
+                }
+                str.push_back(static_cast<char>(c));
+            }
+        }
+        return false;
+    }
+
+    // reads a number, true, false or null, returns false for anything else, e.g. an unquoted string
+    template<typename Source>
+    bool readScalar(Source &is, std::string &str)
+    {
+        str.clear();
+        for (int c = is.peek(); c != std::char_traits<char>::eof() && c != ',' && c != '}' && c != ']' && !std::isspace(c); c = is.peek())
+        {
+            str.push_back(static_cast<char>(is.get()));
+        }
+        if (str == "true" || str == "false" || str == "null")
+        {
+            return true;
+        }
+        return !str.empty() && std::all_of(str.begin(), str.end(), [](const char c) {
+            return std::isdigit(static_cast<unsigned char>(c)) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+        });
+    }
+
+    // reads an array of strings, e.g. the "arguments" field, and hashes every element
+    template<typename Source>
+    bool readStringArray(Source &is, std::uint64_t &hash)
+    {
+        std::string element;
+        for (;;)
+        {
+            skipWhitespace(is);
+            const int c = is.get();
+            if (c == ']')
+            {
+                return true;
+            }
+            if (c == ',')
+            {
+                continue;
+            }
+            if (c == '"')
+            {
+                if (!readString(is, element))
+                {
+                    return false;
+                }
+                hashBytes(hash, element);
+                continue;
+            }
+            return false;
+        }
+    }
+
+    template<typename Source>
+    bool malformed(Source &is)
+    {
+        is.setstate(std::ios::failbit);
+        return false;
+    }
+
+    // consumes the array punctuation before the next entry object, stops after its opening brace
+    template<typename Source>
+    bool readEntryStart(Source &is)
+    {
+        for (;;)
+        {
+            skipWhitespace(is);
+            const int c = is.peek();
+            if (c == std::char_traits<char>::eof() || c == ']')
+            {
+                // the closing bracket is left in the stream, so the caller can tell a complete array from a truncated one
+                return false;
+            }
+            is.get();
+            if (c == '{')
+            {
+                return true;
+            }
+            if (c != '[' && c != ',')
+            {
+                return malformed(is);
+            }
+        }
+    }
+
+    template<typename Source>
+    bool readEntry(Source &is, CompileCommandEntry &entry)
+    {
+        if (!readEntryStart(is))
+        {
+            return false;
+        }
+
+        entry.directory.clear();
+        entry.file.clear();
+        entry.hash = fnvOffsetBasis;
+
+        std::string key;
+        std::string value;
+        for (;;)
+        {
+            skipWhitespace(is);
+            int c = is.get();
+            if (c == '}')
+            {
+                return true;
+            }
+            if (c == ',')
+            {
+                continue;
+            }
+            if (c != '"' || !readString(is, key))
+            {
+                return malformed(is);
+            }
+            skipWhitespace(is);
+            if (is.get() != ':')
+            {
+                return malformed(is);
+            }
+            skipWhitespace(is);
+
+            c = is.peek();
+            if (key == "directory" || key == "file")
+            {
+                is.get();
+                if (c != '"' || !readString(is, key == "directory" ? entry.directory : entry.file))
+                {
+                    return malformed(is);
+                }
+                continue;
+            }
+
+            hashBytes(entry.hash, key);
+            if (c == '"')
+            {
+                is.get();
+                if (!readString(is, value))
+                {
+                    return malformed(is);
+                }
+                hashBytes(entry.hash, value);
+            }
+            else if (c == '[')
+            {
+                is.get();
+                if (!readStringArray(is, entry.hash))
+                {
+                    return malformed(is);
+                }
+            }
+            else
+            {
+                if (!readScalar(is, value))
+                {
+                    return malformed(is);
+                }
+                hashBytes(entry.hash, value);
+            }
+        }
+    }
+} // namespace
+
+bool readCompileCommandEntry(std::istream &is, CompileCommandEntry &entry)
+{
+    return readEntry(is, entry);
+}
+
+bool CompileCommandsDiff::loadPrevious(const std::string &filePath)
+{
+    if (!fs::exists(filePath))
+    {
+        return true;
+    }
+    std::ifstream ifs(filePath);
+    if (!ifs.is_open())
+    {
+        std::cerr << "Error opening file: " << filePath << std::endl;
+        return false;
+    }
+
+    CompileCommandEntry entry;
+    while (readCompileCommandEntry(ifs, entry))
+    {
+        auto &indices = m_previousIndex[entry.directory + '\0' + entry.file];
+        indices.push_back(m_previousEntries.size());
+        m_previousEntries.push_back({std::move(entry.directory), std::move(entry.file), entry.hash});
+    }
+    if (ifs.peek() != ']')
+    {
+        // a partial index would report every entry past the damage as added, which is worse than no change list
+        std::cerr << "cannot parse " << filePath << ", delete it to report every entry as added" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void CompileCommandsDiff::probe(std::string_view chunk)
+{
+    StringViewSource    source(chunk);
+    CompileCommandEntry entry;
+    while (readEntry(source, entry))
+    {
+        auto iter = m_previousIndex.find(entry.directory + '\0' + entry.file);
+        if (m_previousIndex.end() == iter)
+        {
+            writeChange("added", entry.directory, entry.file);
+            ++m_added;
+            continue;
+        }
+
+        // the same directory+file can appear more than once, so an entry without an unchanged counterpart is only paired
+        // with a changed one by finish(), once it can no longer take the unchanged counterpart of a later entry
+        const auto unchanged = std::find_if(iter->second.begin(), iter->second.end(), [this, &entry](const size_t index) {
+            return !m_previousEntries[index].matched && m_previousEntries[index].hash == entry.hash;
+        });
+        if (iter->second.end() != unchanged)
+        {
+            m_previousEntries[*unchanged].matched = true;
+            continue;
+        }
+        m_pendingEntries.push_back({std::move(entry.directory), std::move(entry.file)});
+    }
+}
+
+void CompileCommandsDiff::finish()
+{
+    for (auto &pendingEntry : m_pendingEntries)
+    {
+        const auto &indices     = m_previousIndex[pendingEntry.directory + '\0' + pendingEntry.file];
+        const auto  counterpart = std::find_if(indices.begin(), indices.end(), [this](const size_t index) {
+            return !m_previousEntries[index].matched;
+        });
+        if (indices.end() == counterpart)
+        {
+            writeChange("added", pendingEntry.directory, pendingEntry.file);
+            ++m_added;
+            continue;
+        }
+        m_previousEntries[*counterpart].matched = true;
+        writeChange("modified", pendingEntry.directory, pendingEntry.file);
+        ++m_modified;
+    }
+    m_pendingEntries.clear();
+
+    for (const auto &previousEntry : m_previousEntries)
+    {
+        if (!previousEntry.matched)
+        {
+            writeChange("removed", previousEntry.directory, previousEntry.file);
+            ++m_removed;
+        }
+    }
+    writeOpeningBracket();
+    *m_os << "\n]\n";
+    m_os->flush();
+}
+
+void CompileCommandsDiff::writeOpeningBracket()
+{
+    if (!m_isOpened)
+    {
+        *m_os << "[";
+        m_isOpened = true;
+    }
+}
+
+void CompileCommandsDiff::writeChange(const char *change, const std::string &directory, const std::string &file)
+{
+    writeOpeningBracket();
+    *m_os << (m_isFirstChange ? "\n" : ",\n") << R"(  {"change": ")" << change << R"(", "directory": ")" << directory << R"(", "file": ")" << file
+         << "\"}";
+    m_isFirstChange = false;
+}
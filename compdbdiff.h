@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct CompileCommandEntry
+{
+    std::string   directory; // raw JSON string content, escapes are kept as is
+    std::string   file;      // raw JSON string content, escapes are kept as is
+    std::uint64_t hash = 0;  // hash of every other field of the entry
+};
+
+// Reads the next entry object from a compile_commands.json stream or a fragment of one,
+// skipping the surrounding array punctuation. Returns false at the end of input, before the closing bracket of the array,
+// or on malformed input, in which case the failbit of the stream is set.
+bool readCompileCommandEntry(std::istream &is, CompileCommandEntry &entry);
+
+// Compares freshly rendered entries against a previous compile_commands.json with a hash join:
+// the previous database is the build side, indexed by directory+file, and new entries probe it in output order.
+// Added entries are written to the change list as soon as they are probed. An entry whose directory+file is already indexed
+// but has no unchanged counterpart is kept until finish(), which pairs it with a changed one and writes the removed entries.
+// Nothing is written before the first change or finish(), so the output can be attached after loadPrevious().
+class CompileCommandsDiff
+{
+public:
+    // a missing previous database is not an error, every new entry is reported as added;
+    // a malformed one is, since the change list would not be trustworthy
+    bool loadPrevious(const std::string &filePath);
+    void setOutput(std::ostream &os)
+    {
+        m_os = &os;
+    }
+    // probe() and finish() require an output set by setOutput(), probe() takes entries rendered for the new database
+    void probe(std::string_view chunk);
+    void finish();
+
+    [[nodiscard]] size_t added() const
+    {
+        return m_added;
+    }
+    [[nodiscard]] size_t removed() const
+    {
+        return m_removed;
+    }
+    [[nodiscard]] size_t modified() const
+    {
+        return m_modified;
+    }
+
+private:
+    struct PreviousEntry
+    {
+        std::string   directory;
+        std::string   file;
+        std::uint64_t hash    = 0;
+        bool          matched = false;
+    };
+
+    struct PendingEntry
+    {
+        std::string directory;
+        std::string file;
+    };
+
+    void writeOpeningBracket();
+    void writeChange(const char *change, const std::string &directory, const std::string &file);
+
+    std::ostream                                         *m_os = nullptr;
+    std::vector<PreviousEntry>                            m_previousEntries;
+    std::unordered_map<std::string, std::vector<size_t>> m_previousIndex;
+    std::vector<PendingEntry>                             m_pendingEntries;
+    bool                                                  m_isFirstChange = true;
+    bool                                                  m_isOpened      = false;
+    size_t                                                m_added         = 0;
+    size_t                                                m_removed       = 0;
+    size_t                                                m_modified      = 0;
+};
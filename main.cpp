@@ -2,15 +2,23 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
 #include <regex>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 #include <boost/algorithm/string.hpp>
 #include <boost/process.hpp>
 #include <boost/program_options.hpp>
 #include <boost/property_tree/detail/rapidxml.hpp>
 
+#include "clcompileflags.h"
+#include "compdbdiff.h"
+#include "pipeline.h"
 #include "utils.h"
 
 namespace bp       = boost::process;
@@ -43,10 +51,49 @@ void concatenateSearchPaths(std::stringstream &sstream, const std::vector<std::s
     }
 }
 
+// Resolving system include directories spawns reg/vswhere processes, so the result is cached per toolchain
+// and shared by every project (and every worker thread in streaming mode).
+std::string getSystemIncludeOptions(const std::string &toolset, const std::string &sdkVer, bool useOfMFC)
+{
+    static std::mutex                         cacheMutex;
+    static std::map<std::string, std::string> cache;
+
+    const std::string key = toolset + "|" + sdkVer + "|" + (useOfMFC ? "MFC" : "");
+    std::lock_guard   lock(cacheMutex);
+    auto              iter = cache.find(key);
+    if (cache.end() != iter)
+    {
+        return iter->second;
+    }
+
+    std::vector<std::string> systemIncludedDirectories;
+    getVCIncludedDirectories(toolset, systemIncludedDirectories, useOfMFC);
+    getSDKIncludedDirectories(sdkVer, systemIncludedDirectories);
+    std::transform(systemIncludedDirectories.begin(), systemIncludedDirectories.end(), systemIncludedDirectories.begin(), NormalizePathFunctor());
+    std::stringstream sstream;
+    concatenateSearchPaths(sstream, systemIncludedDirectories);
+
+    return cache.emplace(key, sstream.str()).first->second;
+}
+
+std::string getCachedClPath(const std::string &toolset)
+{
+    static std::mutex                         cacheMutex;
+    static std::map<std::string, std::string> cache;
+
+    std::lock_guard lock(cacheMutex);
+    auto            iter = cache.find(toolset);
+    if (cache.end() != iter)
+    {
+        return iter->second;
+    }
+
+    return cache.emplace(toolset, boost::algorithm::replace_all_copy(getClPath(toolset), "\\", "/")).first->second;
+}
+
 std::string getGlobalOptions(const std::vector<std::string> &preprocessorDefinitions,
                              const std::string              &charset,
                              bool                            useOfMFC,
-                             bool                            isMultiThread,
                              bool                            isDLL,
                              const std::string              &toolset,
                              const std::string              &sdkVer)
@@ -71,25 +118,26 @@ std::string getGlobalOptions(const std::vector<std::string> &preprocessorDefinit
     {
         sstream << " /D_AFXDLL";
     }
-    if (isMultiThread)
-    {
-        sstream << " /D_MT";
-    }
     if (isDLL)
     {
         sstream << " /D_DLL";
     }
-
-    std::vector<std::string> systemIncludedDirectories;
-    getVCIncludedDirectories(toolset, systemIncludedDirectories, useOfMFC);
-    getSDKIncludedDirectories(sdkVer, systemIncludedDirectories);
-    std::transform(systemIncludedDirectories.begin(), systemIncludedDirectories.end(), systemIncludedDirectories.begin(), NormalizePathFunctor());
-    concatenateSearchPaths(sstream, systemIncludedDirectories);
+    sstream << getSystemIncludeOptions(toolset, sdkVer, useOfMFC);
 
     return sstream.str();
 }
 
-bool parseVcxprojFile(const std::string &filePath, const std::string &target, std::ofstream &ofs)
+struct ProjectCommands
+{
+    std::string              directory;
+    std::string              clPath;
+    std::string              languageStandard;  // C++ sources only
+    std::string              languageStandardC; // C sources only
+    std::string              options;
+    std::vector<std::string> sourceFiles;
+};
+
+bool parseVcxprojFile(const std::string &filePath, const std::string &target, ProjectCommands &project)
 {
     fs::path vcxprojFilePath(fs::absolute(fs::path(filePath)));
     if (!fs::exists(vcxprojFilePath))
@@ -105,7 +153,15 @@ bool parseVcxprojFile(const std::string &filePath, const std::string &target, st
     buffer.push_back('\0');
 
     rapidxml::xml_document<> doc;
-    doc.parse<0>(buffer.data());
+    try
+    {
+        doc.parse<0>(buffer.data());
+    }
+    catch (const rapidxml::parse_error &e)
+    {
+        std::cerr << "cannot parse " << filePath << ": " << e.what() << std::endl;
+        return false;
+    }
 
     auto *rootNode = doc.first_node("Project");
     if (!rootNode)
@@ -211,83 +267,45 @@ bool parseVcxprojFile(const std::string &filePath, const std::string &target, st
         return false;
     }
 
-    std::string languageStandard;
-    auto       *languageStandardNode = clCompileNode->first_node("LanguageStandard");
-    if (languageStandardNode)
+    // translate every setting in one pass, the element/value lookups are compile-time perfect hashes
+    ClCompileSettings settings;
+    for (auto *settingNode = clCompileNode->first_node(); settingNode != nullptr; settingNode = settingNode->next_sibling())
     {
-        languageStandard = std::string(languageStandardNode->value(), languageStandardNode->value_size());
-    }
-    static const std::map<std::string, std::string> languageStandardMap = {
-        {"stdcpp11", "/std:c++11"},
-        {"stdcpp14", "/std:c++14"},
-        {"stdcpp17", "/std:c++17"},
-        {"stdcpp20", "/std:c++20"},
-        {"stdcpp23", "/std:c++23"},
-        {"stdcpplatest", "/std:c++latest"},
-    };
-    auto iter = languageStandardMap.find(languageStandard);
-    if (languageStandardMap.end() != iter)
-    {
-        languageStandard = iter->second;
-    }
-    else
-    {
-        languageStandard = "/std:c++14"; // by default, for MSVC 2015
-    }
-
-    bool  isMultiThread      = false;
-    auto *runtimeLibraryNode = clCompileNode->first_node("RuntimeLibrary");
-    if (runtimeLibraryNode)
-    {
-        const std::string runtimeLibrary(runtimeLibraryNode->value(), runtimeLibraryNode->value_size());
-        isMultiThread = (runtimeLibrary == "MultiThreadedDLL" || runtimeLibrary == "MultiThreaded");
+        applyClCompileSetting({settingNode->name(), settingNode->name_size()}, {settingNode->value(), settingNode->value_size()}, settings);
     }
 
-    auto *additionalIncludedDirectoriesNode = clCompileNode->first_node("AdditionalIncludeDirectories");
-    if (!additionalIncludedDirectoriesNode)
+    if (!settings.hasAdditionalIncludeDirectories)
     {
         std::cerr << "cannot find AdditionalIncludeDirectories node" << std::endl;
         return false;
     }
-    const std::string additionalIncludedDirectoriesStr(additionalIncludedDirectoriesNode->value(), additionalIncludedDirectoriesNode->value_size());
-    std::vector<std::string> additionalIncludedDirectories;
-    boost::algorithm::split(additionalIncludedDirectories, additionalIncludedDirectoriesStr, boost::is_any_of(";"));
-    auto iterRemove = std::remove_if(additionalIncludedDirectories.begin(), additionalIncludedDirectories.end(), [](const auto &str) {
-        return boost::algorithm::starts_with(str, "%(");
-    });
-    additionalIncludedDirectories.erase(iterRemove, additionalIncludedDirectories.end());
+    auto &additionalIncludedDirectories = settings.additionalIncludeDirectories;
     std::transform(
         additionalIncludedDirectories.begin(), additionalIncludedDirectories.end(), additionalIncludedDirectories.begin(), NormalizePathFunctor());
 
-    auto *preprocessorDefinitionsNode = clCompileNode->first_node("PreprocessorDefinitions");
-    if (!preprocessorDefinitionsNode)
+    if (!settings.hasPreprocessorDefinitions)
     {
         std::cerr << "cannot find PreprocessorDefinitions node" << std::endl;
         return false;
     }
-    const std::string        preprocessorDefinitionsStr(preprocessorDefinitionsNode->value(), preprocessorDefinitionsNode->value_size());
-    std::vector<std::string> preprocessorDefinitions;
-    boost::algorithm::split(preprocessorDefinitions, preprocessorDefinitionsStr, boost::is_any_of(";"));
-    iterRemove = std::remove_if(
-        preprocessorDefinitions.begin(), preprocessorDefinitions.end(), [](const auto &str) { return boost::algorithm::starts_with(str, "%("); });
-    preprocessorDefinitions.erase(iterRemove, preprocessorDefinitions.end());
-
+    auto &preprocessorDefinitions = settings.preprocessorDefinitions;
     for (auto &preprocessorDefinition : preprocessorDefinitions)
     {
         boost::algorithm::replace_all(preprocessorDefinition, R"(\)", R"(\\)");
         boost::algorithm::replace_all(preprocessorDefinition, R"(")", R"(/\")");
     }
 
-    static const std::string globalOptionsStr = getGlobalOptions(preprocessorDefinitions, charset, useOfMFC, isMultiThread, isDLL, toolset, sdkVer);
-    std::stringstream        sstream;
-    sstream << globalOptionsStr;
+    std::stringstream sstream;
+    sstream << settings.options;
+    sstream << getGlobalOptions(preprocessorDefinitions, charset, useOfMFC, isDLL, toolset, sdkVer);
     concatenateSearchPaths(sstream, additionalIncludedDirectories);
-    sstream << "\"\n},";
-    const std::string        optionsStr = sstream.str();
-    const std::string        dirStr     = "\n{\n  \"directory\": \"" + vcxprojParentDirStr + "\",\n";
-    static const std::string clPath     = boost::algorithm::replace_all_copy(getClPath(toolset), "\\", "/");
-    static const std::string cppCmd     = R"(  "command": "\")" + clPath + R"(\" /c /TP \")";
-    static const std::string cCmd       = R"(  "command": "\")" + clPath + R"(\" /c /TC \")";
+    sstream << settings.additionalOptions;
+
+    project.directory         = vcxprojParentDirStr;
+    project.clPath            = getCachedClPath(toolset);
+    project.languageStandard  = settings.cppLanguageStandard.empty() ? "/std:c++14" : settings.cppLanguageStandard; // by default, for MSVC 2015
+    project.languageStandardC = settings.cLanguageStandard;
+    project.options           = sstream.str();
 
     for (auto *itemGroupNode = rootNode->first_node("ItemGroup"); itemGroupNode != nullptr; itemGroupNode = itemGroupNode->next_sibling("ItemGroup"))
     {
@@ -302,22 +320,50 @@ bool parseVcxprojFile(const std::string &filePath, const std::string &target, st
             }
             std::string srcFile(includeAttr->value(), includeAttr->value_size());
             std::replace(srcFile.begin(), srcFile.end(), '\\', '/');
-            const bool isCpp = !boost::algorithm::iends_with(srcFile, ".c");
+            project.sourceFiles.push_back(std::move(srcFile));
+        }
+    }
 
-            ofs << dirStr << R"(  "file": ")" << srcFile << "\",\n";
-            if (isCpp)
-            {
-                ofs << cppCmd << srcFile << R"(\" )" << languageStandard;
-            }
-            else
+    return true;
+}
+
+// Both the sequential and the streaming mode go through this, so a project that throws is skipped the same way in each.
+bool tryParseVcxprojFile(const std::string &filePath, const std::string &target, ProjectCommands &project)
+{
+    try
+    {
+        return parseVcxprojFile(filePath, target, project);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "cannot parse " << filePath << ": " << e.what() << std::endl;
+        return false;
+    }
+}
+
+void renderProjectCommands(const ProjectCommands &project, std::ostream &os)
+{
+    for (const auto &srcFile : project.sourceFiles)
+    {
+        const bool isCpp = !boost::algorithm::iends_with(srcFile, ".c");
+
+        os << "\n{\n  \"directory\": \"" << project.directory << "\",\n";
+        os << R"(  "file": ")" << srcFile << "\",\n";
+        os << R"(  "command": "\")" << project.clPath;
+        if (isCpp)
+        {
+            os << R"(\" /c /TP \")" << srcFile << R"(\" )" << project.languageStandard;
+        }
+        else
+        {
+            os << R"(\" /c /TC \")" << srcFile << R"(\")";
+            if (!project.languageStandardC.empty())
             {
-                ofs << cCmd << srcFile << R"(\")";
+                os << ' ' << project.languageStandardC;
             }
-            ofs << optionsStr;
         }
+        os << project.options << "\"\n},";
     }
-
-    return true;
 }
 
 bool parseSlnFile(const std::string &filePath, std::vector<std::string> &inputVcxprojFiles)
@@ -400,7 +446,11 @@ int main(int argc, char *argv[])
 {
     std::vector<std::string> inputFiles;
     std::string              outputDirectory;
+    std::string              changesPath;
     std::string              target;
+    bool                     streaming      = false;
+    size_t                   jobs           = 0;
+    size_t                   memoryBudgetMB = 0;
 
     po::options_description desc("Allowed options");
     desc.add_options()("help,h",
@@ -408,7 +458,13 @@ int main(int argc, char *argv[])
         "output-directory,o", po::value<std::string>(&outputDirectory)->default_value("."), "output directory")(
         "input-path,i",
         po::value<std::vector<std::string>>(&inputFiles)->multitoken(),
-        "input a .sln or .vcxproj file path, or a directory path contains .sln/.vcxproj files, can have multiple inputs");
+        "input a .sln or .vcxproj file path, or a directory path contains .sln/.vcxproj files, can have multiple inputs")(
+        "streaming,s", po::bool_switch(&streaming), "parse, render and write projects concurrently within a bounded memory budget")(
+        "jobs,j", po::value<size_t>(&jobs)->default_value(std::thread::hardware_concurrency()), "number of worker threads per stage in streaming mode")(
+        "memory-budget,m", po::value<size_t>(&memoryBudgetMB)->default_value(256), "memory budget in MiB for buffered output in streaming mode")(
+        "changes,c",
+        po::value<std::string>(&changesPath),
+        "write the entries added, removed or modified since the previous compile_commands.json to a JSON change list file");
 
     po::variables_map varMap;
     po::store(po::parse_command_line(argc, argv, desc), varMap);
@@ -458,35 +514,178 @@ int main(int argc, char *argv[])
             return true;
         return fs::exists(inputVcxprojFile) && fs::last_write_time(inputVcxprojFile) > fs::last_write_time(outputPath);
     });
+
+    // the change list is written to a temporary file that replaces the previous one only when the run succeeds,
+    // so a failed run never leaves a broken or empty change list behind
+    const std::string                  changesTempPath = changesPath + ".tmp";
+    std::ofstream                      changesOfs;
+    std::optional<CompileCommandsDiff> diff;
+    if (!changesPath.empty())
+    {
+        diff.emplace();
+    }
+    auto openChanges = [&changesOfs, &changesTempPath, &diff]() {
+        changesOfs.open(changesTempPath);
+        if (!changesOfs.is_open())
+        {
+            std::cerr << "Error opening file " << changesTempPath << std::endl;
+            return false;
+        }
+        diff->setOutput(changesOfs);
+        return true;
+    };
+    auto discardChanges = [&changesOfs, &changesTempPath]() {
+        changesOfs.close();
+        std::error_code ec;
+        fs::remove(changesTempPath, ec);
+    };
+    auto commitChanges = [&changesOfs, &changesTempPath, &changesPath, &diff]() {
+        diff->finish();
+        changesOfs.close();
+        std::error_code ec;
+        fs::rename(changesTempPath, changesPath, ec);
+        if (ec)
+        {
+            std::cerr << "Error renaming " << changesTempPath << " to " << changesPath << ": " << ec.message() << std::endl;
+            fs::remove(changesTempPath, ec);
+            return false;
+        }
+        return true;
+    };
+
     if (!needUpdate)
     {
+        if (diff && (!openChanges() || !commitChanges()))
+        {
+            return 1;
+        }
         std::cout << "No need to update compile_commands.json" << std::endl;
         return 0;
     }
 
     outputPath = fs::absolute(outputPath).lexically_normal();
+    // the previous database has to be indexed, and the change list has to be writable, before the database is truncated
+    if (diff && (!diff->loadPrevious(outputPath.string()) || !openChanges()))
+    {
+        return 1;
+    }
     std::ofstream ofs(outputPath.string());
 
     if (!ofs.is_open())
     {
         std::cerr << "Error opening file " << outputPath.string() << std::endl;
+        if (diff)
+        {
+            discardChanges();
+        }
         return 1;
     }
 
     ofs << "[";
 
-    for (const auto &inputVcxprojFile : inputVcxprojFiles)
+    // a partial database is newer than every project and would be taken as up to date by the next run
+    auto discardOutput = [&ofs, &outputPath, &diff, &discardChanges]() {
+        ofs.close();
+        std::error_code ec;
+        fs::remove(outputPath, ec);
+        if (diff)
+        {
+            discardChanges();
+        }
+    };
+
+    auto writeChunk = [&ofs, &diff](const std::string &chunk) {
+        ofs << chunk;
+        if (diff)
+        {
+            diff->probe(chunk);
+        }
+    };
+
+    PipelineStats stats;
+    if (streaming)
     {
-        parseVcxprojFile(inputVcxprojFile, target, ofs);
+        const PipelineOptions options {jobs, memoryBudgetMB * 1024 * 1024};
+        try
+        {
+            stats = runOrderedPipeline<ProjectCommands>(
+                inputVcxprojFiles.size(),
+                options,
+                [&](size_t index, ProjectCommands &project) { return tryParseVcxprojFile(inputVcxprojFiles[index], target, project); },
+                [](const ProjectCommands &project) {
+                    std::ostringstream oss;
+                    renderProjectCommands(project, oss);
+                    return std::move(oss).str();
+                },
+                writeChunk);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+            discardOutput();
+            return 1;
+        }
+    }
+    else
+    {
+        for (const auto &inputVcxprojFile : inputVcxprojFiles)
+        {
+            ProjectCommands project;
+            if (tryParseVcxprojFile(inputVcxprojFile, target, project))
+            {
+                // only the change list needs the entries of a project as one chunk
+                if (diff)
+                {
+                    std::ostringstream oss;
+                    renderProjectCommands(project, oss);
+                    writeChunk(std::move(oss).str());
+                }
+                else
+                {
+                    renderProjectCommands(project, ofs);
+                }
+                ++stats.succeeded;
+            }
+            else
+            {
+                ++stats.failed;
+            }
+        }
+    }
+
+    if (stats.succeeded == 0)
+    {
+        std::cerr << "no project is exported" << std::endl;
+        discardOutput();
+        return 1;
     }
 
-    // remove the last comma
-    ofs.seekp(-1, std::ios::cur);
+    // remove the last comma, unless every project has no source file and the opening bracket is the last character
+    if (ofs.tellp() > std::streampos(1))
+    {
+        ofs.seekp(-1, std::ios::cur);
+    }
     ofs << "\n]\n";
     ofs.flush();
     ofs.close();
 
     std::cout << outputPath.string() << " is written" << std::endl;
+    std::cout << stats.succeeded << " projects exported, " << stats.failed << " failed";
+    if (streaming)
+    {
+        std::cout << ", peak buffered output " << stats.peakBufferedBytes / 1024 << " KiB";
+    }
+    std::cout << ", peak RSS " << getPeakResidentSetSize() / (1024 * 1024) << " MiB" << std::endl;
+
+    if (diff)
+    {
+        if (!commitChanges())
+        {
+            return 1;
+        }
+        std::cout << changesPath << " is written: " << diff->added() << " added, " << diff->removed() << " removed, " << diff->modified()
+                  << " modified" << std::endl;
+    }
 
     return 0;
 }
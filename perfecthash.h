@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+// Compile-time perfect hash over a constexpr table whose entries have `element` and `value` string_view members.
+// Keys are hashed once, grouped into buckets, and every bucket gets the smallest displacement that moves all of its
+// keys into free slots (hash and displace), so a lookup costs one key hash, two array reads and one key compare.
+namespace perfect_hash
+{
+    constexpr std::uint32_t hashKey(std::string_view element, std::string_view value)
+    {
+        constexpr std::uint32_t fnvOffsetBasis = 2166136261U;
+        constexpr std::uint32_t fnvPrime       = 16777619U;
+
+        std::uint32_t hash = fnvOffsetBasis;
+        for (const char c : element)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= fnvPrime;
+        }
+        // separate element from value so that ("ab", "c") and ("a", "bc") hash differently
+        hash ^= 0xFFU;
+        hash *= fnvPrime;
+        for (const char c : value)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= fnvPrime;
+        }
+        return hash;
+    }
+
+    constexpr std::uint32_t slotHash(std::uint32_t hash, std::uint32_t displacement)
+    {
+        // murmur3 finalizer
+        hash += displacement * 0x9E3779B9U;
+        hash ^= hash >> 16U;
+        hash *= 0x85EBCA6BU;
+        hash ^= hash >> 13U;
+        hash *= 0xC2B2AE35U;
+        hash ^= hash >> 16U;
+        return hash;
+    }
+
+    template<size_t EntryCount>
+    struct Index
+    {
+        static constexpr size_t slotCount   = std::bit_ceil(EntryCount * 2);
+        static constexpr size_t bucketCount = std::bit_ceil(EntryCount / 4 + 1);
+        static_assert(EntryCount < 0xFFFF, "slot entries are stored as uint16_t");
+
+        std::array<std::uint16_t, bucketCount> displacements {};
+        std::array<std::uint16_t, slotCount>   slots {}; // entry index + 1, 0 for an empty slot
+
+        // returns the index of the matching entry in table, or EntryCount if the key is not in table
+        template<typename Entry>
+        [[nodiscard]] constexpr size_t find(const std::array<Entry, EntryCount> &table, std::string_view element, std::string_view value) const
+        {
+            const auto hash         = hashKey(element, value);
+            const auto displacement = displacements[hash & (bucketCount - 1)];
+            const auto slot         = slots[slotHash(hash, displacement) & (slotCount - 1)];
+            if (slot == 0)
+            {
+                return EntryCount;
+            }
+            const auto &entry = table[slot - 1];
+            return (entry.element == element && entry.value == value) ? slot - 1 : EntryCount;
+        }
+    };
+
+    template<typename Entry, size_t EntryCount>
+    constexpr Index<EntryCount> build(const std::array<Entry, EntryCount> &table)
+    {
+        using IndexType                   = Index<EntryCount>;
+        constexpr size_t bucketMask       = IndexType::bucketCount - 1;
+        constexpr size_t slotMask         = IndexType::slotCount - 1;
+        constexpr size_t maxDisplacements = 0xFFFF;
+
+        IndexType                                      index;
+        std::array<std::uint32_t, EntryCount>          hashes {};
+        std::array<size_t, IndexType::bucketCount + 1> bucketStarts {};
+        for (size_t i = 0; i < EntryCount; ++i)
+        {
+            hashes[i] = hashKey(table[i].element, table[i].value);
+            ++bucketStarts[(hashes[i] & bucketMask) + 1];
+        }
+
+        // group the entry indices by bucket with a counting sort
+        size_t largestBucketSize = 0;
+        for (size_t bucket = 0; bucket < IndexType::bucketCount; ++bucket)
+        {
+            largestBucketSize = std::max(largestBucketSize, bucketStarts[bucket + 1]);
+            bucketStarts[bucket + 1] += bucketStarts[bucket];
+        }
+        std::array<size_t, EntryCount>                 bucketMembers {};
+        std::array<size_t, IndexType::bucketCount + 1> bucketEnds = bucketStarts;
+        for (size_t i = 0; i < EntryCount; ++i)
+        {
+            bucketMembers[bucketEnds[hashes[i] & bucketMask]++] = i;
+        }
+
+        // place the largest buckets first while the slots are still mostly free
+        std::array<size_t, EntryCount> candidateSlots {};
+        for (size_t bucketSize = largestBucketSize; bucketSize > 0; --bucketSize)
+        {
+            for (size_t bucket = 0; bucket < IndexType::bucketCount; ++bucket)
+            {
+                const size_t first = bucketStarts[bucket];
+                if (bucketStarts[bucket + 1] - first != bucketSize)
+                {
+                    continue;
+                }
+                bool isPlaced = false;
+                for (std::uint32_t displacement = 0; !isPlaced && displacement < maxDisplacements; ++displacement)
+                {
+                    isPlaced = true;
+                    for (size_t member = 0; isPlaced && member < bucketSize; ++member)
+                    {
+                        const size_t slot      = slotHash(hashes[bucketMembers[first + member]], displacement) & slotMask;
+                        candidateSlots[member] = slot;
+                        isPlaced               = index.slots[slot] == 0;
+                        for (size_t previous = 0; isPlaced && previous < member; ++previous)
+                        {
+                            isPlaced = candidateSlots[previous] != slot;
+                        }
+                    }
+                    if (isPlaced)
+                    {
+                        for (size_t member = 0; member < bucketSize; ++member)
+                        {
+                            index.slots[candidateSlots[member]] = static_cast<std::uint16_t>(bucketMembers[first + member] + 1);
+                        }
+                        index.displacements[bucket] = static_cast<std::uint16_t>(displacement);
+                    }
+                }
+                if (!isPlaced)
+                {
+                    throw std::logic_error("cannot build perfect hash, duplicated keys in table?");
+                }
+            }
+        }
+        return index;
+    }
+} // namespace perfect_hash
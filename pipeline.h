@@ -0,0 +1,273 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+struct PipelineOptions
+{
+    size_t jobs         = 1;
+    size_t memoryBudget = 0; // bytes of rendered output allowed to be buffered before it is written
+};
+
+struct PipelineStats
+{
+    size_t succeeded         = 0;
+    size_t failed            = 0;
+    size_t bytesWritten      = 0;
+    size_t peakBufferedBytes = 0;
+};
+
+template<typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity(std::max<size_t>(1, capacity)) {}
+
+    // blocks while the queue is full, returns false if the queue has been closed
+    bool push(T value)
+    {
+        std::unique_lock lock(m_mutex);
+        m_notFull.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed)
+        {
+            return false;
+        }
+        m_items.push_back(std::move(value));
+        lock.unlock();
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    // blocks while the queue is empty, returns std::nullopt once the queue is closed and drained
+    std::optional<T> pop()
+    {
+        std::unique_lock lock(m_mutex);
+        m_notEmpty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+        if (m_items.empty())
+        {
+            return std::nullopt;
+        }
+        std::optional<T> value(std::move(m_items.front()));
+        m_items.pop_front();
+        lock.unlock();
+        m_notFull.notify_one();
+        return value;
+    }
+
+    void close()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_closed = true;
+        }
+        m_notEmpty.notify_all();
+        m_notFull.notify_all();
+    }
+
+private:
+    const size_t            m_capacity;
+    std::deque<T>           m_items;
+    std::mutex              m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+    bool                    m_closed = false;
+};
+
+// Runs itemCount items through parse -> render -> write stages. Parse and render run on worker threads,
+// write runs on the calling thread strictly in item order, so the output is identical to a sequential run.
+// A parse worker only picks up a new item while the reorder window has a free slot and the rendered output
+// buffered so far, plus an estimate for the items still in flight, stays under options.memoryBudget.
+// The next item to be written is always admitted, so a budget smaller than one item degrades to sequential.
+// An exception thrown by any stage stops every stage, the workers are joined and the first exception is rethrown.
+//   parse:  bool (size_t index, Parsed &parsed), returns false if the item should be skipped
+//   render: std::string (const Parsed &parsed)
+//   write:  void (const std::string &chunk)
+template<typename Parsed, typename ParseFn, typename RenderFn, typename WriteFn>
+PipelineStats runOrderedPipeline(size_t itemCount, const PipelineOptions &options, ParseFn parse, RenderFn render, WriteFn write)
+{
+    const size_t jobs       = std::max<size_t>(1, options.jobs);
+    const size_t windowSize = jobs * 2;
+
+    std::mutex                                   mutex;
+    std::condition_variable                      admissionCond;
+    std::condition_variable                      writerCond;
+    size_t                                       nextClaim     = 0;
+    size_t                                       nextWrite     = 0;
+    size_t                                       bufferedBytes = 0;
+    std::map<size_t, std::optional<std::string>> reorderWindow;
+    PipelineStats                                stats;
+    std::atomic<bool>                            isAborted(false);
+    std::exception_ptr                           failure;
+
+    BoundedQueue<std::pair<size_t, std::optional<Parsed>>> parsedQueue(windowSize);
+
+    auto canAdmit = [&] {
+        if (nextClaim >= itemCount)
+        {
+            return true;
+        }
+        const size_t inFlight = nextClaim - nextWrite;
+        if (inFlight == 0)
+        {
+            return true;
+        }
+        if (inFlight >= windowSize)
+        {
+            return false;
+        }
+        const size_t averageBytes   = nextWrite > 0 ? stats.bytesWritten / nextWrite : 0;
+        const size_t estimatedBytes = bufferedBytes + (inFlight - reorderWindow.size() + 1) * averageBytes;
+        return estimatedBytes < options.memoryBudget;
+    };
+
+    auto claim = [&]() -> std::optional<size_t> {
+        std::unique_lock lock(mutex);
+        admissionCond.wait(lock, [&] { return isAborted || canAdmit(); });
+        if (isAborted || nextClaim >= itemCount)
+        {
+            return std::nullopt;
+        }
+        return nextClaim++;
+    };
+
+    // keeps the first exception and wakes every stage up so that the threads can be joined
+    auto abortPipeline = [&](std::exception_ptr exception) {
+        {
+            std::lock_guard lock(mutex);
+            if (!failure)
+            {
+                failure = std::move(exception);
+            }
+            isAborted = true;
+        }
+        parsedQueue.close();
+        admissionCond.notify_all();
+        writerCond.notify_all();
+    };
+
+    std::atomic<size_t>      activeParsers(jobs);
+    std::vector<std::thread> workers;
+    workers.reserve(jobs * 2);
+    try
+    {
+        for (size_t i = 0; i < jobs; ++i)
+        {
+            workers.emplace_back([&] {
+                try
+                {
+                    while (auto index = claim())
+                    {
+                        std::optional<Parsed> parsed(std::in_place);
+                        if (!parse(*index, *parsed))
+                        {
+                            parsed.reset();
+                        }
+                        if (!parsedQueue.push({*index, std::move(parsed)}))
+                        {
+                            break;
+                        }
+                    }
+                }
+                catch (...)
+                {
+                    abortPipeline(std::current_exception());
+                }
+                if (--activeParsers == 0)
+                {
+                    parsedQueue.close();
+                }
+            });
+        }
+        for (size_t i = 0; i < jobs; ++i)
+        {
+            workers.emplace_back([&] {
+                try
+                {
+                    while (auto item = parsedQueue.pop())
+                    {
+                        if (isAborted)
+                        {
+                            break;
+                        }
+                        std::optional<std::string> rendered;
+                        if (item->second)
+                        {
+                            rendered = render(*item->second);
+                            item->second.reset();
+                        }
+                        {
+                            std::lock_guard lock(mutex);
+                            bufferedBytes += rendered ? rendered->size() : 0;
+                            stats.peakBufferedBytes = std::max(stats.peakBufferedBytes, bufferedBytes);
+                            reorderWindow.emplace(item->first, std::move(rendered));
+                        }
+                        writerCond.notify_one();
+                    }
+                }
+                catch (...)
+                {
+                    abortPipeline(std::current_exception());
+                }
+            });
+        }
+
+        while (nextWrite < itemCount)
+        {
+            std::optional<std::string> chunk;
+            {
+                std::unique_lock lock(mutex);
+                writerCond.wait(lock, [&] { return isAborted || (!reorderWindow.empty() && reorderWindow.begin()->first == nextWrite); });
+                if (isAborted)
+                {
+                    break;
+                }
+                chunk = std::move(reorderWindow.begin()->second);
+                reorderWindow.erase(reorderWindow.begin());
+            }
+            const size_t chunkSize = chunk ? chunk->size() : 0;
+            if (chunk)
+            {
+                write(*chunk);
+                ++stats.succeeded;
+            }
+            else
+            {
+                ++stats.failed;
+            }
+            chunk.reset();
+            {
+                std::lock_guard lock(mutex);
+                bufferedBytes -= chunkSize;
+                stats.bytesWritten += chunkSize;
+                ++nextWrite;
+            }
+            admissionCond.notify_all();
+        }
+    }
+    catch (...)
+    {
+        abortPipeline(std::current_exception());
+    }
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+
+    return stats;
+}
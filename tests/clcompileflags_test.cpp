@@ -0,0 +1,236 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "clcompileflags.h"
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, std::string_view what)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAILED: " << what << std::endl;
+            ++failures;
+        }
+    }
+
+    void checkEqual(const std::string &actual, std::string_view expected, std::string_view what)
+    {
+        if (actual != expected)
+        {
+            std::cerr << "FAILED: " << what << ": expected [" << expected << "], got [" << actual << "]" << std::endl;
+            ++failures;
+        }
+    }
+
+    bool operator==(const ClCompileSettings &lhs, const ClCompileSettings &rhs)
+    {
+        return lhs.cppLanguageStandard == rhs.cppLanguageStandard && lhs.cLanguageStandard == rhs.cLanguageStandard && lhs.options == rhs.options &&
+               lhs.additionalOptions == rhs.additionalOptions && lhs.additionalIncludeDirectories == rhs.additionalIncludeDirectories &&
+               lhs.preprocessorDefinitions == rhs.preprocessorDefinitions &&
+               lhs.hasAdditionalIncludeDirectories == rhs.hasAdditionalIncludeDirectories &&
+               lhs.hasPreprocessorDefinitions == rhs.hasPreprocessorDefinitions;
+    }
+
+    enum class Target
+    {
+        Options,
+        CppLanguageStandard,
+        CLanguageStandard,
+    };
+
+    struct FlagCase
+    {
+        std::string_view element;
+        std::string_view value;
+        std::string_view flag; // without the leading space, empty if no flag is expected
+        Target           target = Target::Options;
+    };
+
+    // one case per mapped value, every setting of the enumerated kind is covered
+    const FlagCase flagCases[] = {
+        {"LanguageStandard", "Default", "", Target::CppLanguageStandard},
+        {"LanguageStandard", "stdcpp11", "/std:c++11", Target::CppLanguageStandard},
+        {"LanguageStandard", "stdcpp14", "/std:c++14", Target::CppLanguageStandard},
+        {"LanguageStandard", "stdcpp17", "/std:c++17", Target::CppLanguageStandard},
+        {"LanguageStandard", "stdcpp20", "/std:c++20", Target::CppLanguageStandard},
+        {"LanguageStandard", "stdcpp23", "/std:c++23", Target::CppLanguageStandard},
+        {"LanguageStandard", "stdcpplatest", "/std:c++latest", Target::CppLanguageStandard},
+        {"LanguageStandard_C", "Default", "", Target::CLanguageStandard},
+        {"LanguageStandard_C", "stdc11", "/std:c11", Target::CLanguageStandard},
+        {"LanguageStandard_C", "stdc17", "/std:c17", Target::CLanguageStandard},
+        {"LanguageStandard_C", "stdclatest", "/std:clatest", Target::CLanguageStandard},
+        {"RuntimeLibrary", "MultiThreaded", "/MT"},
+        {"RuntimeLibrary", "MultiThreadedDebug", "/MTd"},
+        {"RuntimeLibrary", "MultiThreadedDLL", "/MD"},
+        {"RuntimeLibrary", "MultiThreadedDebugDLL", "/MDd"},
+        {"ExceptionHandling", "false", ""},
+        {"ExceptionHandling", "Sync", "/EHsc"},
+        {"ExceptionHandling", "SyncCThrow", "/EHs"},
+        {"ExceptionHandling", "Async", "/EHa"},
+        {"ConformanceMode", "true", "/permissive-"},
+        {"ConformanceMode", "false", ""},
+        {"TreatWChar_tAsBuiltInType", "true", "/Zc:wchar_t"},
+        {"TreatWChar_tAsBuiltInType", "false", "/Zc:wchar_t-"},
+        {"EnableEnhancedInstructionSet", "NotSet", ""},
+        {"EnableEnhancedInstructionSet", "NoExtensions", "/arch:IA32"},
+        {"EnableEnhancedInstructionSet", "StreamingSIMDExtensions", "/arch:SSE"},
+        {"EnableEnhancedInstructionSet", "StreamingSIMDExtensions2", "/arch:SSE2"},
+        {"EnableEnhancedInstructionSet", "AdvancedVectorExtensions", "/arch:AVX"},
+        {"EnableEnhancedInstructionSet", "AdvancedVectorExtensions2", "/arch:AVX2"},
+        {"EnableEnhancedInstructionSet", "AdvancedVectorExtensions512", "/arch:AVX512"},
+        {"RuntimeTypeInfo", "true", "/GR"},
+        {"RuntimeTypeInfo", "false", "/GR-"},
+        {"WarningLevel", "TurnOffAllWarnings", "/W0"},
+        {"WarningLevel", "Level1", "/W1"},
+        {"WarningLevel", "Level2", "/W2"},
+        {"WarningLevel", "Level3", "/W3"},
+        {"WarningLevel", "Level4", "/W4"},
+        {"WarningLevel", "EnableAllWarnings", "/Wall"},
+        {"TreatWarningAsError", "true", "/WX"},
+        {"TreatWarningAsError", "false", ""},
+        {"Optimization", "Disabled", "/Od"},
+        {"Optimization", "MinSpace", "/O1"},
+        {"Optimization", "MaxSpeed", "/O2"},
+        {"Optimization", "Full", "/Ox"},
+        {"FloatingPointModel", "Precise", "/fp:precise"},
+        {"FloatingPointModel", "Strict", "/fp:strict"},
+        {"FloatingPointModel", "Fast", "/fp:fast"},
+        {"CallingConvention", "Cdecl", "/Gd"},
+        {"CallingConvention", "FastCall", "/Gr"},
+        {"CallingConvention", "StdCall", "/Gz"},
+        {"CallingConvention", "VectorCall", "/Gv"},
+        {"OpenMPSupport", "true", "/openmp"},
+        {"OpenMPSupport", "false", ""},
+        {"UseStandardPreprocessor", "true", "/Zc:preprocessor"},
+        {"UseStandardPreprocessor", "false", ""},
+        {"BufferSecurityCheck", "true", ""},
+        {"BufferSecurityCheck", "false", "/GS-"},
+    };
+
+    void testEnumeratedSettings()
+    {
+        for (const auto &flagCase : flagCases)
+        {
+            const std::string what = std::string(flagCase.element) + "=" + std::string(flagCase.value);
+            ClCompileSettings settings;
+            check(applyClCompileSetting(flagCase.element, flagCase.value, settings), what + " is mapped");
+
+            const std::string expectedOptions = flagCase.flag.empty() ? "" : " " + std::string(flagCase.flag);
+            checkEqual(settings.options, flagCase.target == Target::Options ? expectedOptions : "", what + " options");
+            checkEqual(settings.cppLanguageStandard, flagCase.target == Target::CppLanguageStandard ? flagCase.flag : "", what + " C++ standard");
+            checkEqual(settings.cLanguageStandard, flagCase.target == Target::CLanguageStandard ? flagCase.flag : "", what + " C standard");
+            checkEqual(settings.additionalOptions, "", what + " additional options");
+        }
+
+        // values are trimmed and flags accumulate in document order
+        ClCompileSettings settings;
+        check(applyClCompileSetting("ExceptionHandling", "\n  Sync ", settings), "ExceptionHandling with whitespace is mapped");
+        check(applyClCompileSetting("ConformanceMode", "true", settings), "ConformanceMode=true is mapped");
+        checkEqual(settings.options, " /EHsc /permissive-", "flags accumulate");
+    }
+
+    void testUnmappedSettings()
+    {
+        ClCompileSettings settings;
+        applyClCompileSetting("WarningLevel", "Level3", settings);
+        applyClCompileSetting("PreprocessorDefinitions", "A", settings);
+        const ClCompileSettings expected = settings;
+
+        check(!applyClCompileSetting("PrecompiledHeader", "Use", settings), "unknown element is not mapped");
+        check(settings == expected, "unknown element leaves settings untouched");
+        check(!applyClCompileSetting("WarningLevel", "Level9", settings), "unknown value is not mapped");
+        check(settings == expected, "unknown value leaves settings untouched");
+        check(!applyClCompileSetting("warninglevel", "Level3", settings), "element names are case sensitive");
+        check(settings == expected, "case mismatch leaves settings untouched");
+        check(!applyClCompileSetting("", "", settings), "empty element is not mapped");
+        check(settings == expected, "empty element leaves settings untouched");
+    }
+
+    void testAdditionalIncludeDirectories()
+    {
+        ClCompileSettings settings;
+        check(applyClCompileSetting("AdditionalIncludeDirectories", "inc; ..\\common;;%(AdditionalIncludeDirectories)", settings),
+              "AdditionalIncludeDirectories is mapped");
+        check(settings.hasAdditionalIncludeDirectories, "AdditionalIncludeDirectories is recorded");
+        check(settings.additionalIncludeDirectories == std::vector<std::string> {"inc", "..\\common"}, "AdditionalIncludeDirectories items");
+        checkEqual(settings.options, "", "AdditionalIncludeDirectories adds no options");
+
+        ClCompileSettings emptySettings;
+        check(applyClCompileSetting("AdditionalIncludeDirectories", "", emptySettings), "empty AdditionalIncludeDirectories is mapped");
+        check(emptySettings.hasAdditionalIncludeDirectories && emptySettings.additionalIncludeDirectories.empty(),
+              "empty AdditionalIncludeDirectories is recorded without items");
+    }
+
+    void testPreprocessorDefinitions()
+    {
+        ClCompileSettings settings;
+        check(applyClCompileSetting("PreprocessorDefinitions", "WIN32;;NDEBUG;VERSION=2;%(PreprocessorDefinitions)", settings),
+              "PreprocessorDefinitions is mapped");
+        check(settings.hasPreprocessorDefinitions, "PreprocessorDefinitions is recorded");
+        check(settings.preprocessorDefinitions == std::vector<std::string> {"WIN32", "NDEBUG", "VERSION=2"}, "PreprocessorDefinitions items");
+        checkEqual(settings.options, "", "PreprocessorDefinitions adds no options");
+    }
+
+    void testForcedIncludeFiles()
+    {
+        ClCompileSettings settings;
+        check(applyClCompileSetting("ForcedIncludeFiles", "pch.h;;sub\\config.h;%(ForcedIncludeFiles)", settings), "ForcedIncludeFiles is mapped");
+        checkEqual(settings.options, " /FIpch.h /FIsub/config.h", "ForcedIncludeFiles flags");
+
+        ClCompileSettings quotedSettings;
+        check(applyClCompileSetting("ForcedIncludeFiles", "C:\\My Headers\\force.h", quotedSettings), "ForcedIncludeFiles with spaces is mapped");
+        checkEqual(quotedSettings.options, R"( \"/FIC:/My Headers/force.h\")", "ForcedIncludeFiles path with spaces is quoted");
+    }
+
+    void testDisableSpecificWarnings()
+    {
+        ClCompileSettings settings;
+        check(applyClCompileSetting("DisableSpecificWarnings", "4996; 4251;;%(DisableSpecificWarnings)", settings), "DisableSpecificWarnings is mapped");
+        checkEqual(settings.options, " /wd4996 /wd4251", "DisableSpecificWarnings flags");
+    }
+
+    void testUndefinePreprocessorDefinitions()
+    {
+        ClCompileSettings settings;
+        check(applyClCompileSetting("UndefinePreprocessorDefinitions", "min;;max;%(UndefinePreprocessorDefinitions)", settings),
+              "UndefinePreprocessorDefinitions is mapped");
+        checkEqual(settings.options, " /Umin /Umax", "UndefinePreprocessorDefinitions flags");
+    }
+
+    void testAdditionalOptions()
+    {
+        ClCompileSettings settings;
+        check(applyClCompileSetting("AdditionalOptions", R"( /utf-8 /DPATH="C:\dir" %(AdditionalOptions) )", settings), "AdditionalOptions is mapped");
+        checkEqual(settings.additionalOptions, R"( /utf-8 /DPATH=\"C:\\dir\")", "AdditionalOptions are escaped for JSON");
+        checkEqual(settings.options, "", "AdditionalOptions are kept apart from options");
+
+        ClCompileSettings inheritedSettings;
+        check(applyClCompileSetting("AdditionalOptions", "%(AdditionalOptions)", inheritedSettings), "inherited AdditionalOptions is mapped");
+        checkEqual(inheritedSettings.additionalOptions, "", "inherited AdditionalOptions only adds nothing");
+    }
+} // namespace
+
+int main()
+{
+    testEnumeratedSettings();
+    testUnmappedSettings();
+    testAdditionalIncludeDirectories();
+    testPreprocessorDefinitions();
+    testForcedIncludeFiles();
+    testDisableSpecificWarnings();
+    testUndefinePreprocessorDefinitions();
+    testAdditionalOptions();
+
+    if (failures != 0)
+    {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all checks passed" << std::endl;
+    return 0;
+}
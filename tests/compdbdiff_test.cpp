@@ -0,0 +1,253 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "compdbdiff.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, std::string_view what)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAILED: " << what << std::endl;
+            ++failures;
+        }
+    }
+
+    void checkEqual(const std::string &actual, std::string_view expected, std::string_view what)
+    {
+        if (actual != expected)
+        {
+            std::cerr << "FAILED: " << what << ": expected [" << expected << "], got [" << actual << "]" << std::endl;
+            ++failures;
+        }
+    }
+
+    void checkEqual(size_t actual, size_t expected, std::string_view what)
+    {
+        if (actual != expected)
+        {
+            std::cerr << "FAILED: " << what << ": expected " << expected << ", got " << actual << std::endl;
+            ++failures;
+        }
+    }
+
+    // an entry exactly as main.cpp renders it, the values are raw JSON string content
+    std::string renderEntry(std::string_view directory, std::string_view file, std::string_view command)
+    {
+        std::string entry = "\n{\n  \"directory\": \"";
+        entry.append(directory).append("\",\n  \"file\": \"").append(file).append("\",\n  \"command\": \"").append(command).append("\"\n},");
+        return entry;
+    }
+
+    // a compile_commands.json as main.cpp writes it from the rendered entries
+    std::string renderDatabase(const std::vector<std::string> &entries)
+    {
+        std::string database = "[";
+        for (const auto &entry : entries)
+        {
+            database += entry;
+        }
+        if (database.size() > 1)
+        {
+            database.pop_back();
+        }
+        return database + "\n]\n";
+    }
+
+    struct DiffResult
+    {
+        bool        isLoaded = false;
+        std::string changes;
+        size_t      added    = 0;
+        size_t      removed  = 0;
+        size_t      modified = 0;
+    };
+
+    // loads previous as the previous database, std::nullopt for a missing one, then probes every chunk in order
+    DiffResult runDiff(std::string_view name, const std::optional<std::string> &previous, const std::vector<std::string> &chunks)
+    {
+        const fs::path previousPath = fs::temp_directory_path() / ("compdbdiff_test_" + std::string(name) + ".json");
+        fs::remove(previousPath);
+        if (previous)
+        {
+            std::ofstream(previousPath, std::ios::binary) << *previous;
+        }
+
+        DiffResult          result;
+        CompileCommandsDiff diff;
+        result.isLoaded = diff.loadPrevious(previousPath.string());
+        fs::remove(previousPath);
+        if (!result.isLoaded)
+        {
+            return result;
+        }
+
+        std::ostringstream oss;
+        diff.setOutput(oss);
+        for (const auto &chunk : chunks)
+        {
+            diff.probe(chunk);
+        }
+        diff.finish();
+        result.changes  = oss.str();
+        result.added    = diff.added();
+        result.removed  = diff.removed();
+        result.modified = diff.modified();
+        return result;
+    }
+
+    void testAddedRemovedModified()
+    {
+        const auto previous = renderDatabase({renderEntry("C:/p", "a.cpp", "cl /c a.cpp"), renderEntry("C:/p", "b.cpp", "cl /c b.cpp"),
+                                              renderEntry("C:/p", "c.cpp", "cl /c c.cpp")});
+        // the new entries are split over two chunks, as the projects are written one by one
+        const auto result =
+            runDiff("changes", previous, {renderEntry("C:/p", "a.cpp", "cl /c a.cpp") + renderEntry("C:/p", "b.cpp", "cl /c /O2 b.cpp"), renderEntry("C:/p", "d.cpp", "cl /c d.cpp")});
+
+        check(result.isLoaded, "previous database is loaded");
+        checkEqual(result.added, 1, "added entries");
+        checkEqual(result.removed, 1, "removed entries");
+        checkEqual(result.modified, 1, "modified entries");
+        checkEqual(result.changes,
+                   "[\n"
+                   R"(  {"change": "added", "directory": "C:/p", "file": "d.cpp"},)"
+                   "\n"
+                   R"(  {"change": "modified", "directory": "C:/p", "file": "b.cpp"},)"
+                   "\n"
+                   R"(  {"change": "removed", "directory": "C:/p", "file": "c.cpp"})"
+                   "\n]\n",
+                   "change list");
+
+        const auto unchanged = runDiff("unchanged", previous, {renderEntry("C:/p", "a.cpp", "cl /c a.cpp"), renderEntry("C:/p", "b.cpp", "cl /c b.cpp"), renderEntry("C:/p", "c.cpp", "cl /c c.cpp")});
+        checkEqual(unchanged.added + unchanged.removed + unchanged.modified, 0, "unchanged database has no change");
+        checkEqual(unchanged.changes, "[\n]\n", "empty change list");
+
+        const auto sameFileInOtherDirectory = runDiff("directory", previous, {renderEntry("C:/q", "a.cpp", "cl /c a.cpp")});
+        checkEqual(sameFileInOtherDirectory.added, 1, "an entry is keyed by its directory too");
+        checkEqual(sameFileInOtherDirectory.removed, 3, "every previous entry is removed");
+    }
+
+    void testMissingPrevious()
+    {
+        const auto result = runDiff("missing", std::nullopt, {renderEntry("C:/p", "a.cpp", "cl /c a.cpp") + renderEntry("C:/p", "b.cpp", "cl /c b.cpp")});
+        check(result.isLoaded, "a missing previous database is not an error");
+        checkEqual(result.added, 2, "every entry is added without a previous database");
+
+        const auto empty = runDiff("empty", renderDatabase({}), {renderEntry("C:/p", "a.cpp", "cl /c a.cpp")});
+        check(empty.isLoaded, "an empty previous database is loaded");
+        checkEqual(empty.added, 1, "every entry is added to an empty previous database");
+    }
+
+    void testDuplicateKey()
+    {
+        // the same source file compiled by three projects with different options
+        const auto previous = renderDatabase({renderEntry("C:/p", "shared.cpp", "cl /c /DA shared.cpp"), renderEntry("C:/p", "shared.cpp", "cl /c /DB shared.cpp"),
+                                              renderEntry("C:/p", "shared.cpp", "cl /c /DC shared.cpp")});
+
+        const auto reordered = runDiff("duplicate_reordered", previous,
+                                       {renderEntry("C:/p", "shared.cpp", "cl /c /DC shared.cpp") + renderEntry("C:/p", "shared.cpp", "cl /c /DA shared.cpp") +
+                                        renderEntry("C:/p", "shared.cpp", "cl /c /DB shared.cpp")});
+        checkEqual(reordered.added + reordered.removed + reordered.modified, 0, "reordered duplicates are unchanged");
+
+        // the changed first entry must not take the unchanged counterpart of the entries after it
+        const auto oneChanged = runDiff("duplicate_changed", previous,
+                                        {renderEntry("C:/p", "shared.cpp", "cl /c /DX shared.cpp") + renderEntry("C:/p", "shared.cpp", "cl /c /DB shared.cpp") +
+                                         renderEntry("C:/p", "shared.cpp", "cl /c /DC shared.cpp")});
+        checkEqual(oneChanged.modified, 1, "one changed duplicate is modified");
+        checkEqual(oneChanged.added, 0, "no duplicate is added");
+        checkEqual(oneChanged.removed, 0, "no duplicate is removed");
+
+        const auto oneMore = runDiff("duplicate_added", previous,
+                                     {renderEntry("C:/p", "shared.cpp", "cl /c /DA shared.cpp") + renderEntry("C:/p", "shared.cpp", "cl /c /DB shared.cpp") +
+                                      renderEntry("C:/p", "shared.cpp", "cl /c /DC shared.cpp") + renderEntry("C:/p", "shared.cpp", "cl /c /DD shared.cpp")});
+        checkEqual(oneMore.added, 1, "an extra duplicate is added");
+        checkEqual(oneMore.modified, 0, "an extra duplicate modifies nothing");
+
+        const auto oneLess = runDiff("duplicate_removed", previous,
+                                     {renderEntry("C:/p", "shared.cpp", "cl /c /DA shared.cpp") + renderEntry("C:/p", "shared.cpp", "cl /c /DC shared.cpp")});
+        checkEqual(oneLess.removed, 1, "a missing duplicate is removed");
+        checkEqual(oneLess.modified, 0, "a missing duplicate modifies nothing");
+    }
+
+    void testEscapedQuotes()
+    {
+        const std::string command = R"(\"C:/Program Files/cl.exe\" /c /TP \"src/a b.cpp\" /DNAME=\"value\")";
+        const auto        previous = renderDatabase({renderEntry("C:/p", "src/a b.cpp", command), renderEntry("C:/p", R"(src/\"q\".cpp)", command)});
+
+        const auto unchanged = runDiff("escaped_unchanged", previous, {renderEntry("C:/p", "src/a b.cpp", command) + renderEntry("C:/p", R"(src/\"q\".cpp)", command)});
+        check(unchanged.isLoaded, "escaped quotes are parsed");
+        checkEqual(unchanged.added + unchanged.removed + unchanged.modified, 0, "escaped quotes do not end a string");
+
+        const std::string changedCommand = R"(\"C:/Program Files/cl.exe\" /c /TP \"src/a b.cpp\" /DNAME=\"other\")";
+        const auto        changed = runDiff("escaped_changed", previous, {renderEntry("C:/p", "src/a b.cpp", command) + renderEntry("C:/p", R"(src/\"q\".cpp)", changedCommand)});
+        checkEqual(changed.modified, 1, "a change inside escaped quotes is detected");
+        checkEqual(changed.changes,
+                   "[\n"
+                   R"(  {"change": "modified", "directory": "C:/p", "file": "src/\"q\".cpp"})"
+                   "\n]\n",
+                   "escapes are written as they were read");
+
+        const auto escapedBackslash = runDiff("escaped_backslash", renderDatabase({renderEntry("C:/p", "a.cpp", R"(cl /DDIR=\"C:\\\" a.cpp)")}),
+                                              {renderEntry("C:/p", "a.cpp", R"(cl /DDIR=\"C:\\\" a.cpp)")});
+        check(escapedBackslash.isLoaded, "an escaped backslash before an escaped quote is parsed");
+        checkEqual(escapedBackslash.added + escapedBackslash.removed + escapedBackslash.modified, 0, "an escaped backslash does not escape the next quote");
+    }
+
+    void testTruncatedPrevious()
+    {
+        const auto previous = renderDatabase({renderEntry("C:/p", "a.cpp", "cl /c a.cpp"), renderEntry("C:/p", "b.cpp", "cl /c b.cpp")});
+
+        check(!runDiff("truncated_string", previous.substr(0, previous.find("b.cpp")), {}).isLoaded, "a database truncated inside a string is rejected");
+        check(!runDiff("truncated_entry", previous.substr(0, previous.rfind('}')), {}).isLoaded, "a database truncated inside an entry is rejected");
+        check(!runDiff("truncated_array", previous.substr(0, previous.rfind(']')), {}).isLoaded, "a database without the closing bracket is rejected");
+        check(!runDiff("truncated_empty", std::string(), {}).isLoaded, "an empty file is rejected");
+        check(!runDiff("truncated_garbage", "[\n{\"directory\": \"C:/p\", \"file\": \"a.cpp\", \"command\": cl}\n]\n", {}).isLoaded, "an unquoted string is rejected");
+        check(runDiff("truncated_none", previous, {}).isLoaded, "a complete database is loaded");
+    }
+
+    void testReadEntry()
+    {
+        std::istringstream  iss(R"([{"directory": "C:/p", "arguments": ["ab", "c"], "file": "a.cpp", "output": "a.obj", "id": 1}, )"
+                                R"({"file": "a.cpp", "directory": "C:/p", "arguments": ["a", "bc"], "output": "a.obj", "id": 1}])");
+        CompileCommandEntry first;
+        CompileCommandEntry second;
+        check(readCompileCommandEntry(iss, first), "an entry with an arguments array is read");
+        check(readCompileCommandEntry(iss, second), "an entry with reordered fields is read");
+        checkEqual(first.directory, "C:/p", "directory of an entry");
+        checkEqual(second.file, "a.cpp", "file of an entry");
+        check(first.hash != second.hash, "array elements are hashed apart");
+
+        CompileCommandEntry last;
+        check(!readCompileCommandEntry(iss, last), "no entry after the last one");
+        check(!iss.fail(), "the end of the array is not an error");
+    }
+} // namespace
+
+int main()
+{
+    testAddedRemovedModified();
+    testMissingPrevious();
+    testDuplicateKey();
+    testEscapedQuotes();
+    testTruncatedPrevious();
+    testReadEntry();
+
+    if (failures != 0)
+    {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all checks passed" << std::endl;
+    return 0;
+}
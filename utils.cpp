@@ -4,6 +4,14 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/process.hpp>
 
+#if defined(_WIN32)
+#    define WIN32_LEAN_AND_MEAN
+#    include <windows.h>
+#    include <psapi.h>
+#else
+#    include <sys/resource.h>
+#endif
+
 #include "utils.h"
 
 namespace bp = boost::process;
@@ -219,4 +227,28 @@ std::string getClPath(const std::string &toolset)
     }
 
     return installPath + R"(\VC\Tools\MSVC\)" + mscVer + R"(\bin\Hostx64\x64\cl.exe)";
-}
\ No newline at end of file
+}
+
+// peak resident set size of the current process in bytes, 0 if it cannot be queried
+size_t getPeakResidentSetSize()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#    if defined(__APPLE__)
+    return static_cast<size_t>(usage.ru_maxrss);
+#    else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024; // ru_maxrss is in KiB on Linux
+#    endif
+#endif
+}
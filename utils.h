@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
 bool        getSDKIncludedDirectories(const std::string &sdkVer, std::vector<std::string> &directories);
 void        getVCIncludedDirectories(const std::string &toolset, std::vector<std::string> &directories, bool useOfMFC);
-std::string getClPath(const std::string &toolset);
\ No newline at end of file
+std::string getClPath(const std::string &toolset);
+size_t      getPeakResidentSetSize();